@@ -0,0 +1,98 @@
+#include "myShell.h"
+#include <cstdlib>
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+/**
+ * fuzz target over MyShell::parseLine (variable evaluation, pipe splitting, tokenizer and redirect parsing)
+ * build with libFuzzer: make fuzz
+ * without libFuzzer the standalone main below replays the given files and random mutations of them,
+ * build it with: make parse_fuzzer_standalone
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, std::size_t size) {
+    static MyShell myShell;
+    static bool silenced = false;
+    if (!silenced) { // parse errors are expected, do not flood the output with them
+        std::cerr.rdbuf(NULL);
+        silenced = true;
+    }
+    std::string line(reinterpret_cast<const char *>(data), size);
+    // the shell reads one line at a time with getline, so the line can never contain '\n'
+    line = line.substr(0, line.find('\n'));
+    std::vector<ParsedCommand> parsed;
+    myShell.parseLine(line, parsed);
+    return 0;
+}
+
+#ifndef USE_LIBFUZZER
+
+/**
+ * the chars that have a meaning to the parser, mutations prefer them
+ */
+static const std::string INTERESTING_CHARS = " \\|<>2&$_aZ9\x80\xff";
+
+/**
+ * run one input through the fuzz target
+ */
+static void runOne(const std::string & input) {
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(input.data()), input.size());
+}
+
+/**
+ * randomly insert, replace or erase a few chars of input
+ */
+static std::string mutate(std::string input) {
+    std::size_t num_mutations = 1 + rand() % 8;
+    for (std::size_t i = 0; i < num_mutations; ++i) {
+        std::size_t pos = input.empty() ? 0 : rand() % (input.size() + 1);
+        char c = INTERESTING_CHARS[rand() % INTERESTING_CHARS.size()];
+        switch (rand() % 3) {
+            case 0: input.insert(pos, 1, c); break;
+            case 1: if (pos < input.size()) input[pos] = c; break;
+            default: if (pos < input.size()) input.erase(pos, 1 + rand() % 4); break;
+        }
+    }
+    return input;
+}
+
+/**
+ * usage: parse_fuzzer_standalone [-runs=N] [-max_len=N] file...
+ * every file is run as is, and then N random mutations of its first max_len bytes are run
+ * (default 1000 runs of 4096 bytes, so the big corpus inputs are not mutated as a whole)
+ */
+int main(int argc, char ** argv) {
+    std::size_t runs = 1000;
+    std::size_t max_len = 4096;
+    srand(0); // fixed seed, a failure can be reproduced
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg.compare(0, 6, "-runs=") == 0) {
+            runs = strtoul(arg.c_str() + 6, NULL, 10);
+            continue;
+        }
+        if (arg.compare(0, 9, "-max_len=") == 0) {
+            max_len = strtoul(arg.c_str() + 9, NULL, 10);
+            continue;
+        }
+        std::ifstream ifs(argv[i], std::ios::binary);
+        if (!ifs.good()) {
+            std::cout << "cannot open " << arg << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::stringstream ss;
+        ss << ifs.rdbuf();
+        std::string input = ss.str();
+        runOne(input);
+        input = input.substr(0, max_len);
+        for (std::size_t j = 0; j < runs; ++j) runOne(mutate(input));
+        std::cout << "fuzzed " << arg << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
+
+#endif
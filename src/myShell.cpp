@@ -31,13 +31,21 @@ std::map<std::string, MyShell::Command_Function_Pointer> MyShell::COMMAND_MAP =
 /******HELPER FUNCTIONS*****/
 /***************************/
 
+/**
+ * a valid variable name char can only be an upper or lower letter, a number, or an underscore
+ * c is cast to unsigned char, passing a negative char (byte >= 0x80) to isalnum is undefined
+ */
+bool isVarChar(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
 /**
  * a valid variable name can only contain upper and lower letters, numbers, and underscores
  * 
  */
 bool validateVarName(std::string var) {
     for (std::string::iterator it = var.begin(); it != var.end(); ++it) {
-        if (!isalnum(*it) && *it != '_') return false;
+        if (!isVarChar(*it)) return false;
     }
     return true;
 }
@@ -101,8 +109,8 @@ void MyShell::evaluateVars() {
         else {
             std::size_t start = i + 1;
             std::size_t len = 0;
-            // incrementing len
-            while (start + len < input.size() && validateVarName(input.substr(start, len + 1))) len++;
+            // incrementing len, only the newly added char needs to be checked
+            while (start + len < input.size() && isVarChar(input[start + len])) len++;
             std::string var_name = input.substr(start, len);
             std::string var_value = "";
             std::map<std::string, std::string>::iterator it = vars.find(var_name);
@@ -117,7 +125,8 @@ void MyShell::evaluateVars() {
 /**
  * parse the one-line user input on '|' to get each piped command
  * store all piped commands into std::vector<std::string> MyShell::piped_commands
- * if the last character in MyShell::input is '|', this is regarded as error
+ * if there is any '|' in MyShell::input, an empty (or whitespace only) piped command is regarded as error,
+ * e.g. '|' at the beginning or the end of input, or "||"
  */
 
 void MyShell::parsePipedInput() {
@@ -127,13 +136,16 @@ void MyShell::parsePipedInput() {
         piped_commands.push_back(input.substr(start, pipe_pos - start));
         start = pipe_pos + 1;
     }
-    if (pipe_pos == input.length() - 1) {
-        std::cerr << "cannot have | at the end of input" << std::endl;
-        error = true;
-        return;
-    }
     // push_back the last user input after '|'
     piped_commands.push_back(input.substr(start));
+    if (piped_commands.size() == 1) return; // no pipe, an empty input is fine
+    for (std::vector<std::string>::iterator it = piped_commands.begin(); it != piped_commands.end(); ++it) {
+        if (it->find_first_not_of(' ') == std::string::npos) {
+            std::cerr << "cannot have an empty command in pipe" << std::endl;
+            error = true;
+            return;
+        }
+    }
 }
 
 /**
@@ -148,11 +160,13 @@ void MyShell::parsePipedInput() {
 void MyShell::parseCommand() {
     std::string curr_command = piped_commands[curr_command_index];
     std::string word, modified_curr_command;
+    bool in_word = false; // if word holds a pending (possibly escaped) word
     for (std::size_t end = 0; end < curr_command.size(); ++end) {
         if (curr_command[end] == ' ') { // if it is whitespace
-            if ((end > 0 && curr_command[end-1] != ' ') || (end > 1 && curr_command[end-2] == '\\')) {
-                commands.push_back(std::string(word));
+            if (in_word) {
+                commands.push_back(word);
                 word.erase(); // word here acts like a buffer
+                in_word = false;
             }
             modified_curr_command.push_back(curr_command[end]);
         }
@@ -164,15 +178,15 @@ void MyShell::parseCommand() {
             }
             word.push_back(curr_command[++end]); // put the escaped char into the word stream
             modified_curr_command.push_back(curr_command[end]); // remove the escape mark from the input command
-            if (end == curr_command.size() - 1) commands.push_back(std::string(word));
-            // normal non-space and non-escape chars
+            in_word = true;
         }
-        else {
+        else { // normal non-space and non-escape chars
             word.push_back(curr_command[end]);
             modified_curr_command.push_back(curr_command[end]);
-            if (end == curr_command.size() - 1) commands.push_back(std::string(word));
+            in_word = true;
         }
     }
+    if (in_word) commands.push_back(word);
     piped_commands[curr_command_index] = modified_curr_command;
 }
 
@@ -296,91 +310,126 @@ void MyShell::runExportCommand() {
 }
 
 /**
- * in a child process
- * config redirect input and output
- * <: redirect stdin to the given input file, if the file does not exist, create with permissions
- * >: redirect stdout to the given output file, if the file does not exist, create with permissions
- * 2>: rediect stderr to the given output file, if the file does not exist, create with permissions
- * 2>&1: redirect stderr to the same file as the output file
- * TODO refactor, extract methods
+ * parse the redirect marks in MyShell::commands
+ * remove them and their file names from MyShell::commands, and store the file names into
+ * MyShell::input_filename, MyShell::output_filename and MyShell::error_filename
+ * <: redirect stdin to the given input file
+ * >: redirect stdout to the given output file
+ * 2>: rediect stderr to the given output file
+ * 2>&1: redirect stderr to wherever stdout points at this point, like a POSIX shell does
+ *       before any >: stderr goes to the original stdout (terminal or pipe), MyShell::error_to_original_output
+ *       after a >: stderr goes to the output file, MyShell::error_to_output,
+ *       if a later > changes stdout, stderr stays on the earlier output file
+ * a format error is regarded as error, no file is opened here
  * 
  */
-void MyShell::configCommandRedirect() {
-    std::string input_filename;
-    std::string output_filename;
-    std::string error_filename;
-    for (std::vector<std::string>::iterator it = commands.begin() + 1; it != commands.end(); ) {
-        std::string curr = *it;
+void MyShell::parseCommandRedirect() {
+    std::vector<std::string> args(1, commands[0]); // commands without the redirect marks and file names
+    for (std::size_t i = 1; i < commands.size(); ++i) {
+        const std::string & curr = commands[i];
         if (curr.compare(0, 1, "<") == 0) {
             if (curr.size() == 1) { // curr == "<"
-                if (it + 1 == commands.end()) {
+                if (i + 1 == commands.size()) {
                     std::cerr << "incorrect input format: < requires an input file" << std::endl;
-                    exit(EXIT_FAILURE);
-                }
-                else {
-                    input_filename = *(it + 1);
-                    commands.erase(it);
-                    commands.erase(it); // no need for it++ again
+                    error = true;
+                    return;
                 }
+                input_filename = commands[++i]; // skip the file name
             }
-            else { // curr starts with "<"
-                input_filename = curr.substr(1);
-                commands.erase(it); // no need for it++ again
-            }
+            else input_filename = curr.substr(1); // curr starts with "<"
         }
         else if (curr.compare(0, 1, ">") == 0) {
             if (curr.size() == 1) {
-                if (it + 1 == commands.end()) {
+                if (i + 1 == commands.size()) {
                     std::cerr << "incorrect input format: > requires an output file" << std::endl;
-                    exit(EXIT_FAILURE);
+                    error = true;
+                    return;
                 }
-                else {
-                    output_filename = *(it + 1);
-                    commands.erase(it);
-                    commands.erase(it); // no need for it++ again
+                if (error_to_output) { // stderr keeps the earlier output file
+                    error_filename = output_filename;
+                    error_to_output = false;
                 }
+                output_filename = commands[++i];
             }
             else {
+                if (error_to_output) {
+                    error_filename = output_filename;
+                    error_to_output = false;
+                }
                 output_filename = curr.substr(1);
-                commands.erase(it); // no need for it++ again
             }
         }
+        else if (curr.compare("2>&1") == 0) {
+            error_filename.clear();
+            error_to_original_output = output_filename.empty();
+            error_to_output = !output_filename.empty();
+        }
         else if (curr.compare(0, 2, "2>") == 0) {
-            if (curr.size() == 2){
-                if (it + 1 == commands.end()) {
+            if (curr.size() == 2) {
+                if (i + 1 == commands.size()) {
                     std::cerr << "incorrect input format: 2> requires an output file" << std::endl;
-                    exit(EXIT_FAILURE);
-                }
-                else {
-                    error_filename = *(it + 1);
-                    commands.erase(it);
-                    commands.erase(it); // no need for it++ again
+                    error = true;
+                    return;
                 }
+                error_filename = commands[++i];
             }
-            else {
-                if (curr.compare("2>&1") == 0) error_filename = output_filename;
-                else error_filename = curr.substr(2);
-            }
-            commands.erase(it); // no need for it++ again
+            else error_filename = curr.substr(2);
+            error_to_original_output = false; // the later stderr redirect wins
+            error_to_output = false;
         }
-        else it++;
+        else args.push_back(curr);
+    }
+    commands.swap(args);
+    if (!input_filename.empty() && curr_command_index != 0) { // only the first piped command can redirect stdin
+        std::cerr << "cannot redirect stdin for a non-head command in pipe" << std::endl;
+        error = true;
+        return;
+    }
+    if (!output_filename.empty() && curr_command_index != piped_commands.size() - 1) { // only the last piped command can redirect stdout
+        std::cerr << "cannot redirect stdout for a non-end command in pipe" << std::endl;
+        error = true;
     }
+}
+
+/**
+ * parse piped_commands[curr_command_index] into MyShell::commands and its redirects
+ * the redirects of the previous piped command are cleared first
+ * built-in commands (exit, cd, set, export) do not support redirect, their arguments are kept as is
+ * used by both MyShell::runPipedCommands and MyShell::parseLine
+ */
+void MyShell::parsePipedCommand() {
+    commands.clear();
+    input_filename.clear();
+    output_filename.clear();
+    error_filename.clear();
+    error_to_original_output = false;
+    error_to_output = false;
+    parseCommand();
+    if (error || commands.empty()) return;
+    if (COMMAND_MAP.find(commands[0]) == COMMAND_MAP.end()) parseCommandRedirect();
+}
+
+/**
+ * in a child process, after MyShell::configCommandPipe
+ * config redirect input and output
+ * the redirects are parsed in the parent process by MyShell::parsePipedCommand
+ * if the file does not exist, create with permissions
+ * 2>&1 duplicates fd 1 instead of opening the output file again, so stdout and stderr share one file offset
+ * 
+ */
+void MyShell::configCommandRedirect() {
     if (!input_filename.empty()) {
-        if (curr_command_index != 0) { // only the first piped command can redirect stdin
-            std::cerr << "cannot redirect stdin for a non-head command in pipe" << std::endl;
-            exit(EXIT_FAILURE);
-        }
         close(0);
         if (open(input_filename.c_str(), O_RDONLY, 0) < 0) {
             std::cerr << "cannot open the redirect input file: " << std::strerror(errno) << std::endl;
             exit(EXIT_FAILURE);
         }
     }
+    if (error_to_original_output && dup2(1, 2) < 0) {
+        std::cerr << "failed to redirect stderr: " << std::strerror(errno) << std::endl;
+        exit(EXIT_FAILURE);
+    }
     if (!output_filename.empty()) {
-        if (curr_command_index != piped_commands.size() - 1) { // only the last piped command can redirect stdout
-            std::cerr << "cannot redirect stdout for a non-end command in pipe" << std::endl;
-            exit(EXIT_FAILURE);
-        }
         close(1);
         // set file permission
         if (open(output_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666) < 0) {
@@ -395,6 +444,10 @@ void MyShell::configCommandRedirect() {
             exit(EXIT_FAILURE);
         }
     }
+    if (error_to_output && dup2(1, 2) < 0) {
+        std::cerr << "failed to redirect stderr: " << std::strerror(errno) << std::endl;
+        exit(EXIT_FAILURE);
+    }
 }
 
 /**
@@ -443,8 +496,9 @@ void MyShell::runCommand() {
         error = true;
     }
     else if (forkResult == 0) {
-        configCommandRedirect();
+        // pipe first, so that 2>&1 before > duplicates the pipe for a non-end command
         configCommandPipe();
+        configCommandRedirect();
         char ** c_commands = vector2array(commands);
         // if the child calls execve right after forking, the second copy of the parent's memory is destroyed and replaced
         // with a memory image loaded from the requested binary
@@ -460,7 +514,7 @@ void MyShell::runCommand() {
  * create pipes for all piped commands
  */
 void MyShell::createPipes() {
-    int num_pipes = piped_commands.size() - 1;
+    std::size_t num_pipes = piped_commands.size() - 1;
     pipefd = new int[2 * num_pipes]; // 2 * number of pipe marks, R and W
     for (std::size_t i = 0; i < num_pipes; ++i) {
         if (pipe(pipefd + 2 * i) < 0) { // R end: 2 * i, W end: 2 * i + 1
@@ -476,7 +530,7 @@ void MyShell::createPipes() {
  * close all pipe fds before waiting for child processes
  */
 void MyShell::closePipes() {
-    int num_pipes = piped_commands.size() - 1;
+    std::size_t num_pipes = piped_commands.size() - 1;
     for (std::size_t i = 0; i < 2 * num_pipes; i++) {
         if (close(pipefd[i]) < 0) {
             std::cerr << "failed to close pipe " << i << ": " << std::strerror(errno) << std::endl;
@@ -512,7 +566,7 @@ void MyShell::runPipedCommands() {
     createPipes();
     for (curr_command_index = 0; curr_command_index < piped_commands.size(); ++curr_command_index) {
         if (error) break; // if any error occur previously during the execution of this input, stop
-        parseCommand();
+        parsePipedCommand();
         if (error) break; // if error occur during parsing command, stop
         if (!commands.empty()) { // if command is not empty
             std::string command_name = commands[0];
@@ -541,7 +595,7 @@ void MyShell::runPipedCommands() {
 
 /**
  * set the error indicator to false
- * remove contents of input, piped_commands and commands
+ * remove contents of input, piped_commands, commands and redirect file names
  * reset curr_command_index and num_child_processes to 0
  * update environment variables in case other programs change them
  */
@@ -550,6 +604,11 @@ void MyShell::refresh() {
     input.clear();
     piped_commands.clear();
     commands.clear();
+    input_filename.clear();
+    output_filename.clear();
+    error_filename.clear();
+    error_to_original_output = false;
+    error_to_output = false;
     curr_command_index = 0;
     num_child_processes = 0;
 }
@@ -563,7 +622,7 @@ void MyShell::refresh() {
  * initialize some class variables
  * set up env vars once
  */
-MyShell::MyShell(): error(false), exitting(false), curr_command_index(0), num_child_processes(0) {
+MyShell::MyShell(): error(false), exitting(false), error_to_original_output(false), error_to_output(false), curr_command_index(0), num_child_processes(0) {
     // environment is represented as an array of strings. Each string is of the format 'name=value'. 
     // The last element of the array is a null pointer
     // Variable is declared in header file unistd.h.
@@ -599,6 +658,35 @@ void MyShell::execute() {
     }
 }
 
+/**
+ * parse one line of user input the same way MyShell::execute does, but without running it
+ * each piped command goes through MyShell::parsePipedCommand, as in MyShell::runPipedCommands
+ * no child process is forked and no redirect file is opened
+ * the argv and redirect file names of each piped command are appended to parsed
+ * return false if the line has a parse error
+ * used by the parser fuzz target and the differential parse test
+ */
+bool MyShell::parseLine(const std::string & line, std::vector<ParsedCommand> & parsed) {
+    refresh();
+    input = line;
+    evaluateVars();
+    parsePipedInput();
+    for (curr_command_index = 0; curr_command_index < piped_commands.size(); ++curr_command_index) {
+        if (error) break;
+        parsePipedCommand();
+        if (error) break;
+        ParsedCommand parsed_command;
+        parsed_command.commands = commands;
+        parsed_command.input_filename = input_filename;
+        parsed_command.output_filename = output_filename;
+        parsed_command.error_filename = error_filename;
+        parsed_command.error_to_original_output = error_to_original_output;
+        parsed_command.error_to_output = error_to_output;
+        parsed.push_back(parsed_command);
+    }
+    return !error;
+}
+
 /**
  * return to the caller if the shell is going to exit
  * i.e., in the previous step the user gives "exit" commands
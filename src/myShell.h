@@ -4,6 +4,16 @@
 #include <vector>
 #include <string>
 
+// the argv and redirect file names of one parsed piped command
+struct ParsedCommand {
+    std::vector<std::string> commands;
+    std::string input_filename;
+    std::string output_filename;
+    std::string error_filename;
+    bool error_to_original_output; // 2>&1 before any >: stderr duplicates stdout before the > redirect
+    bool error_to_output; // 2>&1 after a >: stderr duplicates stdout after the > redirect
+};
+
 class MyShell {
 private:
     typedef void (MyShell::*Command_Function_Pointer)();
@@ -13,6 +23,11 @@ private:
     std::string input; // initial one-liner user input
     std::vector<std::string> piped_commands; // piped commands in user input
     std::vector<std::string> commands; // one command and its arguments
+    std::string input_filename; // redirect file names of the current command
+    std::string output_filename;
+    std::string error_filename;
+    bool error_to_original_output; // 2>&1 of the current command, see ParsedCommand
+    bool error_to_output;
     int * pipefd; // an array of pipe fd used to run piped commands
     std::size_t curr_command_index;
     std::size_t num_child_processes; // number of child processes forked
@@ -26,6 +41,8 @@ private:
     void runCdCommand();
     void runSetCommand();
     void runExportCommand();
+    void parseCommandRedirect();
+    void parsePipedCommand();
     void configCommandRedirect();
     void configCommandPipe(bool redirect_input, bool redirect_output);
     void runCommand();
@@ -37,6 +54,7 @@ private:
 public:
     MyShell();
     void execute();
+    bool parseLine(const std::string & line, std::vector<ParsedCommand> & parsed);
     bool isExitting();
 };
 
@@ -0,0 +1,159 @@
+#include "myShell.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <dirent.h>
+
+/**
+ * differential parse test of MyShell::parseLine
+ * 1. every line in PARSE_CASES is parsed, and the argv and redirect file names are compared with the expected ones
+ * 2. every file in the given corpus directory is parsed and timed, a file taking longer than TIME_BUDGET_MS fails
+ * usage: parse_test [corpus_dir]
+ */
+
+// any corpus input has to be parsed within this time, catches quadratic behavior on the big inputs
+static const long TIME_BUDGET_MS = 250;
+
+struct ParseCase {
+    std::string line;
+    bool ok; // if the line is expected to parse without error
+    std::vector<ParsedCommand> expected; // compared only if ok
+};
+
+static const ParseCase PARSE_CASES[] = {
+    {"echo a b", true, {{{"echo", "a", "b"}, "", "", ""}}},
+    {"  echo   a  ", true, {{{"echo", "a"}, "", "", ""}}},
+    {"echo a\\ b c", true, {{{"echo", "a b", "c"}, "", "", ""}}},
+    {"echo a\\\\ b", true, {{{"echo", "a\\", "b"}, "", "", ""}}},
+    {"echo \\\\  x", true, {{{"echo", "\\", "x"}, "", "", ""}}},
+    {"echo a\\ ", true, {{{"echo", "a "}, "", "", ""}}},
+    {"echo a\\", false, {}},
+    {"echo $PARSE_TEST_VAR", true, {{{"echo", "hello"}, "", "", ""}}},
+    {"echo $PARSE_TEST_VAR.x $NO_SUCH_VAR", true, {{{"echo", "hello.x"}, "", "", ""}}},
+    {"echo $PARSE_TEST_VAR\xe9 $PARSE_TEST_VAR_", true, {{{"echo", "hello\xe9"}, "", "", ""}}},
+    {"cat | sort | uniq", true, {{{"cat"}, "", "", ""}, {{"sort"}, "", "", ""}, {{"uniq"}, "", "", ""}}},
+    {"", true, {{{}, "", "", ""}}},
+    {"   ", true, {{{}, "", "", ""}}},
+    {"/bin/echo a |", false, {}},
+    {"/bin/echo a | ", false, {}},
+    {"a || b", false, {}},
+    {"a |  | b", false, {}},
+    {"| a", false, {}},
+    {"cat < in", true, {{{"cat"}, "in", "", ""}}},
+    {"cat <in >out", true, {{{"cat"}, "in", "out", ""}}},
+    {"cat a > out b", true, {{{"cat", "a", "b"}, "", "out", ""}}},
+    {"cat a 2>err", true, {{{"cat", "a"}, "", "", "err"}}},
+    {"cat 2> err", true, {{{"cat"}, "", "", "err"}}},
+    {"cmd 2> f b", true, {{{"cmd", "b"}, "", "", "f"}}},
+    {"cmd < in > out 2> err b", true, {{{"cmd", "b"}, "in", "out", "err"}}},
+    {"cat > out 2>&1", true, {{{"cat"}, "", "out", "", false, true}}},
+    {"cat 2>&1 > out", true, {{{"cat"}, "", "out", "", true, false}}},
+    {"cat 2>&1 2>err", true, {{{"cat"}, "", "", "err", false, false}}},
+    {"cat 2>err 2>&1 >out", true, {{{"cat"}, "", "out", "", true, false}}},
+    {"cat > a 2>&1 > b", true, {{{"cat"}, "", "b", "a", false, false}}},
+    {"cat > out 2>&1 2>err", true, {{{"cat"}, "", "out", "err", false, false}}},
+    {"cat 2>&1", true, {{{"cat"}, "", "", "", true, false}}},
+    {"cat 2>&1 | sort", true, {{{"cat"}, "", "", "", true, false}, {{"sort"}, "", "", ""}}},
+    {"cat 2>", false, {}},
+    {"cd > x", true, {{{"cd", ">", "x"}, "", "", ""}}},
+    {"export A <in", true, {{{"export", "A", "<in"}, "", "", ""}}},
+    {"cat <", false, {}},
+    {"cat >", false, {}},
+    {"cat | sort < in", false, {}},
+    {"cat > out | sort", false, {}},
+};
+
+/**
+ * print one parsed command for a failure report
+ */
+static std::string describe(const ParsedCommand & parsed) {
+    std::ostringstream oss;
+    oss << "[";
+    for (std::size_t i = 0; i < parsed.commands.size(); ++i) {
+        oss << (i ? ", " : "") << "\"" << parsed.commands[i] << "\"";
+    }
+    oss << "] <" << parsed.input_filename << " >" << parsed.output_filename << " 2>" << parsed.error_filename;
+    if (parsed.error_to_original_output) oss << " 2>&1 before >";
+    if (parsed.error_to_output) oss << " 2>&1 after >";
+    return oss.str();
+}
+
+static bool equal(const ParsedCommand & a, const ParsedCommand & b) {
+    return a.commands == b.commands && a.input_filename == b.input_filename
+        && a.output_filename == b.output_filename && a.error_filename == b.error_filename
+        && a.error_to_original_output == b.error_to_original_output && a.error_to_output == b.error_to_output;
+}
+
+/**
+ * run all PARSE_CASES, return the number of failed cases
+ */
+static std::size_t runParseCases(MyShell & myShell) {
+    std::size_t failures = 0;
+    for (std::size_t i = 0; i < sizeof(PARSE_CASES) / sizeof(PARSE_CASES[0]); ++i) {
+        const ParseCase & parse_case = PARSE_CASES[i];
+        std::vector<ParsedCommand> parsed;
+        bool ok = myShell.parseLine(parse_case.line, parsed);
+        bool same = ok == parse_case.ok;
+        if (same && ok) {
+            same = parsed.size() == parse_case.expected.size()
+                && std::equal(parsed.begin(), parsed.end(), parse_case.expected.begin(), equal);
+        }
+        if (!same) {
+            failures++;
+            std::cout << "FAIL \"" << parse_case.line << "\"" << std::endl;
+            std::cout << "  expected " << (parse_case.ok ? "ok" : "error") << std::endl;
+            for (std::size_t j = 0; j < parse_case.expected.size(); ++j) std::cout << "    " << describe(parse_case.expected[j]) << std::endl;
+            std::cout << "  got " << (ok ? "ok" : "error") << std::endl;
+            for (std::size_t j = 0; j < parsed.size(); ++j) std::cout << "    " << describe(parsed[j]) << std::endl;
+        }
+    }
+    return failures;
+}
+
+/**
+ * parse and time every file in corpus_dir, return the number of files over TIME_BUDGET_MS
+ */
+static std::size_t runCorpus(MyShell & myShell, const std::string & corpus_dir) {
+    std::vector<std::string> names;
+    DIR * dir = opendir(corpus_dir.c_str());
+    if (dir == NULL) {
+        std::cout << "FAIL cannot open corpus directory " << corpus_dir << std::endl;
+        return 1;
+    }
+    struct dirent * entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') names.push_back(entry->d_name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    std::size_t failures = 0;
+    for (std::vector<std::string>::iterator it = names.begin(); it != names.end(); ++it) {
+        std::ifstream ifs((corpus_dir + "/" + *it).c_str(), std::ios::binary);
+        std::string line;
+        std::getline(ifs, line); // the shell reads one line at a time
+        std::vector<ParsedCommand> parsed;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        myShell.parseLine(line, parsed);
+        long elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        bool over_budget = elapsed_ms > TIME_BUDGET_MS;
+        if (over_budget) failures++;
+        std::cout << (over_budget ? "FAIL " : "ok   ") << *it << " (" << line.size() << " bytes): " << elapsed_ms << " ms" << std::endl;
+    }
+    return failures;
+}
+
+int main(int argc, char ** argv) {
+    setenv("PARSE_TEST_VAR", "hello", 1);
+    MyShell myShell; // picks up PARSE_TEST_VAR from environ
+    std::streambuf * cerr_buf = std::cerr.rdbuf(NULL); // parse errors are expected, keep the report readable
+    std::size_t failures = runParseCases(myShell);
+    if (argc > 1) failures += runCorpus(myShell, argv[1]);
+    std::cerr.rdbuf(cerr_buf);
+    std::cout << (failures ? "FAILED: " : "passed: ") << failures << " failure(s)" << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}